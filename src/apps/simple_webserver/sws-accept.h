@@ -25,6 +25,7 @@
 void init_accept(int port);
 
 #define NB_MAX_ACCEPTS          8
+#define NB_ACCEPTS(nthreads)    ((nthreads) > NB_MAX_ACCEPTS ? (nthreads) : NB_MAX_ACCEPTS)  /* Accept colors */
 
 #if ACCEPT_PER_INTERFACE
  static char * interfaces[] = { "192.168.20.51", "192.168.21.51", "192.168.22.51", "192.168.23.51", "192.168.24.51", "192.168.25.51", "192.168.26.51", "192.168.27.51"};
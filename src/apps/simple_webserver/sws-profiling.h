@@ -26,8 +26,6 @@
 
 void print_handler_stats();
 
-#define HANDLER_RATE_BASE                       2330000000UL
-
 /** Profiling **/
 typedef struct{
    uint64_t nb_calls;
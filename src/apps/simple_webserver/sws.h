@@ -128,6 +128,22 @@
 
 #define ACCEPT_PER_CORE                         0
 
+/** With ACCEPT_PER_CORE: one SO_REUSEPORT listen socket per thread instead of one shared by all
+ * threads, so that they do not contend on the same accept queue (see init_accept). **/
+#define ACCEPT_REUSEPORT                        0
+/** How the kernel spreads the connections over the listeners of ACCEPT_REUSEPORT:
+ * - ACCEPT_STEER_HASH: hash of the addresses and ports (SO_REUSEPORT default)
+ * - ACCEPT_STEER_CBPF: listener of the thread pinned on the CPU which got the SYN (SO_ATTACH_REUSEPORT_CBPF)
+ * - ACCEPT_STEER_INCOMING_CPU: same preference, expressed with SO_INCOMING_CPU (recent kernels), hash otherwise **/
+#define ACCEPT_STEER_HASH                       0
+#define ACCEPT_STEER_CBPF                       1
+#define ACCEPT_STEER_INCOMING_CPU               2
+#define ACCEPT_STEERING                         ACCEPT_STEER_CBPF
+
+#if ACCEPT_REUSEPORT && (!ACCEPT_PER_CORE || ACCEPT_PER_INTERFACE)
+#error "ACCEPT_REUSEPORT needs ACCEPT_PER_CORE, and does not support ACCEPT_PER_INTERFACE"
+#endif
+
 #define REUSE_MESSAGES                          0
 
 /****************** Colorig options ************************/
@@ -168,6 +184,18 @@
 #endif //PER_FREQUENT_FILE_DISTRIB_COLOR
 
 
+/** 1: let the runtime measure the duration of the handlers (time left stealing), 0: use the cycles below **/
+#define MEASURED_HANDLER_DURATIONS 1
+
+#if MEASURED_HANDLER_DURATIONS
+#define READ_REQ_DURATION        0
+#define PARSE_REQUEST_DURATION   0
+#define CIC_DURATION             0
+#define WRITE_DURATION           0
+#define FREE_REQ_DURATION        0
+#define CLOSE_DURATION           0
+#define ACCEPT_DURATION          0
+#else
 #define READ_REQ_DURATION        43000 // 21000
 #define PARSE_REQUEST_DURATION   22000 // 2000
 #define CIC_DURATION             20000 // 2500
@@ -175,6 +203,7 @@
 #define FREE_REQ_DURATION        400
 #define CLOSE_DURATION           14000
 #define ACCEPT_DURATION          165000
+#endif
 
 
 /*******************************************************/
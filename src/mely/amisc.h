@@ -54,8 +54,7 @@ extern timespec tsnow;
 extern const time_t &timenow;
 
 void ainitialize();
-void acheck_task();
-void acheck_task_norepeat();
+int acheck(bool may_block);
 
 extern cbv cbv_null;
 extern cbi cbi_null;
@@ -63,7 +62,6 @@ extern cbi cbi_null;
 void close_on_exec (int s);
 int _make_async (int);
 int color_to_thread(int color);
-void _epoll_steal(int color, int victim_number);
 
 /*
  * Other random stuff
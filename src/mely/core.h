@@ -25,5 +25,7 @@
 
 void wakeup_fdwatcher(int watcher);
 void change_fd_to_core(int fd, int new_color, selop op);
+void clock_init();
+void cb_pool_init();
 
 #endif /*CORE_H_*/
@@ -24,12 +24,13 @@
 
 #include "mely.h"
 #include "task.lbc.h"
-#include "itree.h"
+#include "timer_wheel.h"
 #define PRIVATE __thread
 
-void fdcb_fdwatcher_check();
+int fdcb_fdwatcher_check(bool may_block);
 void init_fdwatcher();
 void ainit_fdwatcher();
+void init_private_stuff();
 
 typedef union __attribute__((__packed__,  __aligned__(CACHE_LINE_SIZE))) __timeval__t {
    timeval val;
@@ -38,8 +39,7 @@ typedef union __attribute__((__packed__,  __aligned__(CACHE_LINE_SIZE))) __timev
 #define fdwatcher_wait(thread) _fdwatcher_wait[thread].val
 
 extern int maxfd;
-extern int fdwatcher_gotany[MAX_THREADS];
-extern timeval_tt _fdwatcher_wait[MAX_THREADS];
+extern timeval_tt *_fdwatcher_wait;
 
 #define CORE_STATS                    (thread_stats[get_current_proc()].val)
 
@@ -66,33 +66,67 @@ extern timeval_tt _fdwatcher_wait[MAX_THREADS];
 #define UNLOCK(lock_addr)      sl_mutex_unlock(lock_addr)
 #endif
 
+/**
+ * Timers are recycled (never freed) so that a stale timecb_handle_t can always be checked:
+ * the generation is bumped each time a timer is reused. State and generation are in the same
+ * word and change with a single CAS.
+ **/
+enum timecb_state {
+   TIMECB_PENDING,                        /* Waiting in the wheel (or in the inbox) of its thread */
+   TIMECB_FIRED,                          /* Expired, do_timecb posted */
+   TIMECB_RUNNING,                        /* do_timecb runs the callback, too late to cancel */
+   TIMECB_CANCELLED,                      /* Cancelled, the callback will never run */
+};
+#define TIMECB_STATE_BITS                 2
+#define TIMECB_WORD(gen, state)           (((gen) << TIMECB_STATE_BITS) | (state))
+#define TIMECB_GEN(word)                  ((word) >> TIMECB_STATE_BITS)
+/** Timers are cache line aligned: the low bits of a timecb_t * given to the application keep its generation **/
+#define TIMECB_PTR_GEN_MASK               (CACHE_LINE_SIZE - 1UL)
+
 struct timecb_t {
-        timespec ts;
+        struct timer_node node;         /* In the wheel, the inbox or a free list of thread */
+        struct timecb_t *cancel_next;   /* In the cancel inbox of thread */
         cbv cb;
-        itree_entry<timecb_t> link;
-        int cancel;
-        timecb_t(const timespec &t, cbv c) : ts(t), cb(c), cancel(0)  {
-        }
+        int thread;
+        bool in_wheel;                  /* Only read and written by thread */
+        volatile unsigned long word;    /* TIMECB_WORD(generation, state) */
 };
 
+typedef struct fd_epoll {
+   int thread;                            /* Epoll the fd is registered in (thread number + 1), 0 if none */
+   uint32_t events;                       /* EPOLLIN/EPOLLOUT armed, 0 if disarmed (EPOLL_ONESHOT) */
+   uint32_t gen;                          /* IO_URING: bumped by each poll (URING_GEN_BITS), to ignore stale completions */
+} fd_epoll_t;
+
 typedef struct fdcb_list {
    struct fdcb_list* next;
    CBV_PTR_TYPE cb;
 } fdcb_list_t;
 
-typedef struct fdcol_list {
-	struct fdcol_list* next;
-	int fd;
-
-}fdclo_list_t;
+/**
+ * One direction (selread or selwrite) of a fd. Its callbacks form a FIFO: the first
+ * FD_INLINE_CBS ones are stored inline (circularly), the next ones in a list of fdcb_list_t
+ * allocated from the callback pools.
+ **/
+#define FD_INLINE_CBS                     2
 
-typedef struct fdbc_list_container {
-   struct fdcb_list* head;
-   struct fdcb_list* tail;
-} fdbc_list_container_t;
+typedef struct fd_dir {
+   CBV_PTR_TYPE cbs[FD_INLINE_CBS];
+   fdcb_list_t *more_head;                /* Callbacks after the inline ones */
+   fdcb_list_t *more_tail;
+   uint8_t first;                         /* Head of cbs */
+   uint8_t count;                         /* Callbacks in cbs */
+   uint8_t queued;                        /* The head callback was posted (do_fd_check) */
+} fd_dir_t;
 
-typedef struct fd_list_container {
-	struct fdcol_list* head;
-	struct fdcol_list* tail;
-}fd_list_container_t;
+/**
+ * Everything the fd watcher knows about a fd: two cache lines.
+ * With STEALING, the thread whose epoll reports the fd and the thread running the color of its
+ * callbacks may differ until the fd is re-armed (see _epoll_update): lock serializes them.
+ **/
+typedef struct fd_state {
+   fd_epoll_t reg;                        /* What is registered in epoll (see _epoll_update) */
+   lock_t lock;                           /* STEALING only */
+   fd_dir_t dir[2];                       /* Indexed by selop */
+} __attribute__((aligned(CACHE_LINE_SIZE))) fd_state_t;
 #endif /* CORE_FDWATCHER_H_ */
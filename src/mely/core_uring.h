@@ -0,0 +1,54 @@
+/*
+ *
+ * Copyright (C) 2010 Sardes Project INRIA France
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ *
+ */
+
+#ifndef CORE_URING_H_
+#define CORE_URING_H_
+
+#include <sys/epoll.h>
+#include <stdint.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define HAVE_IO_URING 1
+#endif
+#endif
+
+/**
+ * io_uring backend of the fd watcher (IO_URING runtime parameter, see core_uring.C).
+ * Used by core_epoll.C in place of epoll_wait/epoll_ctl.
+ **/
+bool uring_init();                                         /* false if the kernel can't do it */
+void uring_init_thread(int thread);
+void uring_poll_add(int thread, int fd, uint32_t events, uint32_t gen, bool multishot);
+void uring_poll_remove(int thread, int fd, uint32_t gen); /* Submitted at once */
+int uring_wait(int thread, struct epoll_event *events, int maxevents, int timeout_ms,
+               int *nb_done);                              /* Completions of requests posted */
+void uring_submit(int thread);                             /* SQEs queued by the tasks of thread */
+
+/** Generations of the polls of a fd (see fd_epoll_t): the user_data of a poll has room for 30 bits **/
+#define URING_GEN_BITS                    30
+#define URING_NEXT_GEN(gen)               (((gen) + 1) & ((1U << URING_GEN_BITS) - 1))
+
+/** Poll completions are returned as epoll events, data.u64 = fd | gen << 32 **/
+#define URING_EVENT_FD(ev)                ((int) ((ev).data.u64 & 0xffffffffULL))
+#define URING_EVENT_GEN(ev)               ((uint32_t) ((ev).data.u64 >> 32))
+
+#endif /* CORE_URING_H_ */
@@ -28,15 +28,75 @@
 
 template<class R, class B1 = void, class B2 = void, class B3 = void> class callback;
 
+/* With the CB_POOLS runtime parameter, callbacks are allocated from per-thread pools (see cb_pool.C) */
+extern int cb_pools_on;
+void *cb_alloc (size_t size);
+void cb_free (void *p, size_t size);
+
+/**
+ * Each callback embeds its node of the scheduler task lists, so that posting a callback
+ * allocates nothing but the callback itself. This changes the layout of callbacks: the library
+ * and the applications must be compiled with the same value.
+ */
+#ifndef INTRUSIVE_TASKS
+#define INTRUSIVE_TASKS 0
+#endif
+
+/**
+ * Node of the scheduler task lists (Task in the runtime, see task.lbc.h).
+ * Dummy nodes delimit the task list of a color.
+ */
+struct mely_task {
+  callback<void> *cb;
+  mely_task *next;
+  mely_task *prev;
+  bool dummy;
+  int color;
+  int prio;
+  int duration;  /* Time left (cycles) counted in its list, the callback's or an estimate (TIME_LEFT_WORKSTEALING) */
+
+  mely_task () {}
+  inline mely_task (callback<void> *c);
+  mely_task (int task_color) : cb (NULL), next (NULL), prev (NULL), dummy (true),
+           color (task_color), prio (0), duration (0) {
+  }
+  void clear () {
+    cb = NULL;
+  }
+  inline void setcb (callback<void> *c);
+};
+
+/**
+ * Identity of a member function handler, whose pointer is not an address: a hash of the callback
+ * class (its vtable, which depends on the class of the object) and of the member pointer bytes.
+ * The top bit is set, so that it is not the address of a function.
+ **/
+static inline void *
+cb_member_handler (const void *cb, const void *f, size_t size)
+{
+  unsigned long h = *(const unsigned long *) cb;
+  const unsigned char *b = (const unsigned char *) f;
+  for (size_t i = 0; i < size; i++)
+    h = (h ^ b[i]) * 0x100000001b3UL;
+  return (void *) (h | (1UL << (sizeof (long) * 8 - 1)));
+}
+
 template<class R>
 class callback<R> {
 public:
+#if INTRUSIVE_TASKS
+  mely_task task;
+#endif
+  static void *operator new (size_t size) { return cb_pools_on ? cb_alloc (size) : ::operator new (size); }
+  static void operator delete (void *p, size_t size) { if (cb_pools_on) cb_free (p, size); else ::operator delete (p); }
   virtual int getcolor () = 0;
   virtual int getprio () = 0;
   virtual int get_timeleft () = 0;
   virtual void setFlagAutoFree(bool flag) = 0;
   virtual bool getFlagAutoFree() = 0;
   virtual void* getfaddr () = 0;
+  /* Identity of the handler: its address, or cb_member_handler for member functions */
+  virtual void* gethandler () = 0;
   virtual R operator() () = 0;
   virtual ~callback () {}
 };
@@ -66,6 +126,7 @@ public:
     bool getFlagAutoFree () { return AutoFree; }
 
   void* getfaddr (){ return (void *)f; }
+  void* gethandler (){ return (void *)f; }
 
   R operator() ()
     { return f (); }
@@ -114,6 +175,7 @@ public:
   void setFlagAutoFree (bool flag) { AutoFree = flag; }
   bool getFlagAutoFree () { return AutoFree; }
   void* getfaddr (){ return (void *)&f; }
+  void* gethandler (){ return cb_member_handler (this, &f, sizeof (f)); }
   R operator() ()
     { return ((*c).*f) (); }
 };
@@ -180,6 +242,7 @@ public:
   void setFlagAutoFree (bool flag) { AutoFree = flag; }
   bool getFlagAutoFree () { return AutoFree; }
   void* getfaddr (){ return (void *)f; }
+  void* gethandler (){ return (void *)f; }
   R operator() ()
     { return f (a1); }
 };
@@ -228,6 +291,7 @@ public:
   void setFlagAutoFree (bool flag) { AutoFree = flag; }
   bool getFlagAutoFree () { return AutoFree; }
   void* getfaddr (){ return (void *)&f; }
+  void* gethandler (){ return cb_member_handler (this, &f, sizeof (f)); }
   R operator() ()
     { return ((*c).*f) (a1); }
 };
@@ -295,6 +359,7 @@ public:
   void setFlagAutoFree (bool flag) { AutoFree = flag; }
   bool getFlagAutoFree () { return AutoFree; }
   void* getfaddr (){ return (void *)f; }
+  void* gethandler (){ return (void *)f; }
   R operator() ()
     { return f (a1, a2); }
 };
@@ -349,6 +414,7 @@ public:
   void setFlagAutoFree (bool flag) { AutoFree = flag; }
   bool getFlagAutoFree () { return AutoFree; }
   void* getfaddr (){ return (void *)&f; }
+  void* gethandler (){ return cb_member_handler (this, &f, sizeof (f)); }
   R operator() ()
     { return ((*c).*f) (a1, a2); }
 };
@@ -417,6 +483,7 @@ public:
   void setFlagAutoFree (bool flag) { AutoFree = flag; }
   bool getFlagAutoFree () { return AutoFree; }
   void* getfaddr (){ return (void *)f; }
+  void* gethandler (){ return (void *)f; }
   R operator() ()
     { return f (a1, a2, a3); }
 };
@@ -467,6 +534,7 @@ public:
   void setFlagAutoFree (bool flag) { AutoFree = flag; }
   bool getFlagAutoFree () { return AutoFree; }
   void* getfaddr (){ return (void *)&f; }
+  void* gethandler (){ return cb_member_handler (this, &f, sizeof (f)); }
   R operator() ()
     { return ((*c).*f) (a1, a2, a3); }
 };
@@ -536,6 +604,7 @@ public:
   void setFlagAutoFree (bool flag) { AutoFree = flag; }
   bool getFlagAutoFree () { return AutoFree; }
   void* getfaddr (){ return (void *)f; }
+  void* gethandler (){ return (void *)f; }
   R operator() ()
     { return f (a1, a2, a3, a4); }
 };
@@ -589,6 +658,7 @@ public:
   void setFlagAutoFree (bool flag) { AutoFree = flag; }
   bool getFlagAutoFree () { return AutoFree; }
   void* getfaddr (){ return (void *)&f; }
+  void* gethandler (){ return cb_member_handler (this, &f, sizeof (f)); }
   R operator() ()
     { return ((*c).*f) (a1, a2, a3, a4); }
 };
@@ -659,6 +729,7 @@ public:
   void setFlagAutoFree (bool flag) { AutoFree = flag; }
   bool getFlagAutoFree () { return AutoFree; }
   void* getfaddr (){ return (void *)f; }
+  void* gethandler (){ return (void *)f; }
   R operator() ()
     { return f (a1, a2, a3, a4, a5); }
 };
@@ -711,6 +782,7 @@ public:
   void setFlagAutoFree (bool flag) { AutoFree = flag; }
   bool getFlagAutoFree () { return AutoFree; }
   void* getfaddr (){ return (void *)&f; }
+  void* gethandler (){ return cb_member_handler (this, &f, sizeof (f)); }
   R operator() ()
     { return ((*c).*f) (a1, a2, a3, a4, a5); }
 };
@@ -756,6 +828,8 @@ cpwrap (const C &p, R (C::*f) (A1, A2, A3, A4, A5), const AA1 &a1, const AA2 &a2
 template<class R, class B1>
 class callback<R, B1> {
 public:
+  static void *operator new (size_t size) { return cb_pools_on ? cb_alloc (size) : ::operator new (size); }
+  static void operator delete (void *p, size_t size) { if (cb_pools_on) cb_free (p, size); else ::operator delete (p); }
   virtual int getcolor () = 0;
   virtual int getprio () = 0;
   virtual R operator() (B1) = 0;
@@ -1468,6 +1542,8 @@ cpwrap (const C &p, R (C::*f) (A1, A2, A3, A4, A5, B1), const AA1 &a1, const AA2
 template<class R, class B1, class B2>
 class callback<R, B1, B2> {
 public:
+  static void *operator new (size_t size) { return cb_pools_on ? cb_alloc (size) : ::operator new (size); }
+  static void operator delete (void *p, size_t size) { if (cb_pools_on) cb_free (p, size); else ::operator delete (p); }
   virtual int getcolor () = 0;
   virtual int getprio () = 0;
   virtual R operator() (B1, B2) = 0;
@@ -2180,6 +2256,8 @@ cpwrap (const C &p, R (C::*f) (A1, A2, A3, A4, A5, B1, B2), const AA1 &a1, const
 template<class R, class B1, class B2, class B3>
 class callback {
 public:
+  static void *operator new (size_t size) { return cb_pools_on ? cb_alloc (size) : ::operator new (size); }
+  static void operator delete (void *p, size_t size) { if (cb_pools_on) cb_free (p, size); else ::operator delete (p); }
   virtual int getcolor () = 0;
   virtual int getprio () = 0;
   virtual void* getfaddr () = 0;
@@ -23,8 +23,8 @@
 #ifndef _ASYNC_ASYNC_H_
 #define _ASYNC_ASYNC_H_ 1
 
-#define MAX_COLORS                                      32764
-#define MAX_THREADS      8
+/** Default size of the color space (colors are taken modulo this value). Can be changed at startup, see runtime_params.h **/
+#define DEFAULT_MAX_COLORS                              32764
 
 #include <stdlib.h>
 #include <string.h>
@@ -33,6 +33,7 @@
 #include <pthread.h>
 #include <netinet/in.h>
 #include <assert.h>
+#include <stdint.h>
 #include "callback_norefcount.h"                         /* Definitions of various wrap() functions */
 
 
@@ -45,14 +46,39 @@ enum selop { selread = 0, selwrite = 1 };
 void fdcb (int, selop, CBV_PTR_TYPE);                      /* Associate fd and callback */
 void fdcb_finished(bool finished);                         /* Work to be done in a fd callback is done */
                                                            /* Allows to get to the next write cb. */
-timecb_t *timecb (const timespec &ts, cbv cb);             /* Time -> callback */
-timecb_t *delaycb (time_t sec, u_int32_t nsec, cbv cb);    /* Now + sec -> callback */
-void timecb_remove (timecb_t *);                           /* Remove callback */
+timecb_t *timecb (const timespec &ts, cbv cb,             /* Time -> callback, up to slack_us late */
+                  int slack_us = -1);                      /* (-1: TIMER_SLACK runtime parameter) */
+timecb_t *delaycb (time_t sec, u_int32_t nsec, cbv cb,    /* Now + sec -> callback */
+                   int slack_us = -1);
+void timecb_remove (timecb_t *);                           /* Remove callback (which must not have run: */
+                                                           /* prefer the handles, checked by generation) */
+typedef struct {                                           /* Generation checked timer handle */
+   struct timecb_t *timer;
+   unsigned long gen;
+} timecb_handle_t;
+timecb_handle_t timecb_handle (const timespec &ts, cbv cb, /* timecb, returning a handle */
+                               int slack_us = -1);
+timecb_handle_t delaycb_handle (time_t sec, u_int32_t nsec, cbv cb, /* delaycb, returning a handle */
+                                int slack_us = -1);
+bool timecb_cancel (timecb_handle_t);                      /* Remove callback, false if it already ran */
+                                                           /* (or runs, or was removed) */
+
+/**
+ * Completion based I/O, with the IO_URING runtime parameter (see core_uring.C). cb gets the result
+ * (or -errno). aaccept and arecv go on until cb gets -errno (or 0, end of stream, for arecv).
+ **/
+void aread (int fd, void *buf, size_t len, cbi cb);
+void awrite (int fd, const void *buf, size_t len, cbi cb);
+void aaccept (int fd, cbi cb);                             /* cb runs for each new connection */
+void arecv (int fd, callback<void, int, char *> *cb);      /* cb runs for each recv, with a buffer */
+void arecv_release (char *buf);                            /* Give a buffer of arecv back */
 
 int get_current_color();
 unsigned int get_current_proc();
 int task_get_nthreads();
 #define async_get_nthreads task_get_nthreads /*Legacy*/
+int task_get_cpu(int thread);                               /* CPU the thread is pinned on (if nthreads > 1) */
+void *calloc_aligned(size_t nmemb, size_t size);           /* Zeroed, cache line aligned (per-thread tables) */
 
 void save_bench_time(unsigned long bench_time);
 void dump_current_state(bool separation);
@@ -64,7 +90,7 @@ void register_atempty_handler(void (*fun)(void));           /* Register an handl
 void reset_runtime_stats();                                 /** Reset runtime stats (for all threads) **/
 void stop_hw_counters();                                    /** Papi counter interface **/
 
-void register_task_avg_duration(int avg_duration);          /** Tweak for steal **/
+void register_task_avg_duration(int avg_duration);          /** Duration (cycles) assumed for handlers not measured yet (time left stealing) **/
 
 
 #define DEBUG(...)
@@ -87,6 +113,27 @@ void register_task_avg_duration(int avg_duration);          /** Tweak for steal
    #define rdtscll(val) __asm__ __volatile__("rdtsc" : "=A" (val))
 #endif
 
+/** Clock (clock.C): ns of CLOCK_MONOTONIC, from the TSC calibrated at startup **/
+#define TSC_SHIFT 32
+extern uint64_t _tsc_mult;
+extern __thread uint64_t _time_now_ns;
+uint64_t read_time_ns();                                    /* Now, also refreshes get_time_ns() */
+uint64_t ns_to_cycles(uint64_t ns);
+uint64_t get_tsc_hz();                                      /* Cycles per second */
+
+/** Time the current task started: refreshed once per scheduler loop iteration, no clock read **/
+static inline uint64_t get_time_ns() {
+   return _time_now_ns ? _time_now_ns : read_time_ns();
+}
+
+static inline uint64_t cycles_to_ns(uint64_t cycles) {
+#ifdef __x86_64__
+   return (uint64_t) (((unsigned __int128) cycles * _tsc_mult) >> TSC_SHIFT);
+#else
+   return (cycles >> TSC_SHIFT) * _tsc_mult + (((cycles & ((1ULL << TSC_SHIFT) - 1)) * _tsc_mult) >> TSC_SHIFT);
+#endif
+}
+
 #define reset_threads_queue() PANIC("Not implemented in MELY");
 /** Async init, to avoid calling a init_async() in main... */
 static class async_init {
@@ -30,7 +30,7 @@
 extern "C" {
 #endif
 
-typedef volatile struct {
+typedef volatile struct sl_mutex {
    PAD(lock_t) l;
 } sl_mutex_t;
 #define LOCK_CONTENT lock->l.val
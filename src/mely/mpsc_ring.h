@@ -0,0 +1,217 @@
+/*
+ *
+ * Copyright (C) 2010 Sardes Project INRIA France
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ *
+ */
+
+/**
+ * Bounded multi-producer / single-consumer ring of callbacks.
+ * Each thread owns one: other threads push the callbacks they post to it,
+ * the owner pops them and inserts them in its task lists.
+ *
+ * Producers claim a cell with a CAS on tail, the consumer never uses atomic
+ * read-modify-writes.
+ * Each cell carries a sequence number telling whether it is free (seq == pos)
+ * or filled (seq == pos + 1) for the lap of position pos.
+ *
+ * When the ring is full, callbacks go to a lock-protected overflow list. Once
+ * the overflow list is used, producers keep using it until the owner drained it,
+ * so that the posts of a given producer stay in order.
+ *
+ * "Owner" functions are called by one thread at a time: the owner, or a thief
+ * holding the owner's task lock (see steal_work in task.lbc.C).
+ */
+
+#ifndef MPSC_RING_H_
+#define MPSC_RING_H_
+
+#include <stdlib.h>
+#include <assert.h>
+#include "mely.h"
+#include "pad.h"
+#include "lock.h"
+
+struct mpsc_cell {
+   volatile unsigned long seq;
+   CBV_PTR_TYPE cb;
+   char last;
+};
+
+struct mpsc_overflow {
+   struct mpsc_overflow *next;
+   CBV_PTR_TYPE cb;
+   char last;
+};
+
+typedef struct {
+   PAD(volatile unsigned long) tail;         /* MANIPULATED BY ALL THREADS - next cell to claim */
+   PAD(unsigned long) head;                  /* Owner only - next cell to consume */
+   PAD(volatile long) in_flight[2];          /* MANIPULATED BY ALL THREADS - producers between mpsc_enter and mpsc_leave, per phase */
+   volatile int phase;                       /* Owner only (written) - phase of the producers entering now */
+
+   struct mpsc_cell *cells;
+   unsigned long mask;
+
+   sl_mutex_t overflow_mu;                   /* Protects the overflow list */
+   volatile int overflow_pending;
+   struct mpsc_overflow *overflow_first;
+   struct mpsc_overflow *overflow_last;
+} mpsc_ring_t;
+
+static inline void mpsc_init(mpsc_ring_t *r, unsigned long size) {
+   assert(size > 0 && (size & (size - 1)) == 0);
+
+   r->cells = (struct mpsc_cell *) calloc(size, sizeof(*r->cells));
+   assert(r->cells);
+   for (unsigned long i = 0; i < size; i++)
+      r->cells[i].seq = i;
+
+   r->mask = size - 1;
+   r->tail.val = 0;
+   r->head.val = 0;
+   r->in_flight[0].val = 0;
+   r->in_flight[1].val = 0;
+   r->phase = 0;
+
+   sl_mutex_init(&r->overflow_mu);
+   r->overflow_pending = 0;
+   r->overflow_first = NULL;
+   r->overflow_last = NULL;
+}
+
+/* Returns 0 if the ring is full */
+static inline int mpsc_try_push(mpsc_ring_t *r, CBV_PTR_TYPE cb, char last) {
+   unsigned long pos = r->tail.val;
+   for (;;) {
+      struct mpsc_cell *c = &r->cells[pos & r->mask];
+      long dif = (long) __atomic_load_n(&c->seq, __ATOMIC_ACQUIRE) - (long) pos;
+
+      if (dif == 0) {
+         if (__sync_bool_compare_and_swap(&r->tail.val, pos, pos + 1)) {
+            c->cb = cb;
+            c->last = last;
+            __atomic_store_n(&c->seq, pos + 1, __ATOMIC_RELEASE);    /* Publish the cell */
+            return 1;
+         }
+         pos = r->tail.val;
+      } else if (dif < 0) {
+         return 0;
+      } else {
+         pos = r->tail.val;
+      }
+   }
+}
+
+/* Returns 1 if the callback went to the overflow list */
+static inline int mpsc_push(mpsc_ring_t *r, CBV_PTR_TYPE cb, char last) {
+   if (!r->overflow_pending && mpsc_try_push(r, cb, last))
+      return 0;
+
+   struct mpsc_overflow *o = (struct mpsc_overflow *) malloc(sizeof(*o));
+   assert(o);
+   o->next = NULL;
+   o->cb = cb;
+   o->last = last;
+
+   sl_mutex_lock(&r->overflow_mu);
+   if (r->overflow_last)
+      r->overflow_last->next = o;
+   else
+      r->overflow_first = o;
+   r->overflow_last = o;
+   r->overflow_pending = 1;
+   sl_mutex_unlock(&r->overflow_mu);
+   return 1;
+}
+
+/* Owner only. Returns 0 if the ring is empty */
+static inline int mpsc_pop(mpsc_ring_t *r, CBV_PTR_TYPE *cb, char *last) {
+   unsigned long pos = r->head.val;
+   struct mpsc_cell *c = &r->cells[pos & r->mask];
+
+   if (__atomic_load_n(&c->seq, __ATOMIC_ACQUIRE) != pos + 1)
+      return 0;
+
+   *cb = c->cb;
+   *last = c->last;
+   __atomic_store_n(&c->seq, pos + r->mask + 1, __ATOMIC_RELEASE);   /* Give the cell back for the next lap */
+   r->head.val = pos + 1;
+   return 1;
+}
+
+/* Owner only. Cells claimed so far: mpsc_pop_before drains up to there */
+static inline unsigned long mpsc_claimed(mpsc_ring_t *r) {
+   return __atomic_load_n(&r->tail.val, __ATOMIC_ACQUIRE);
+}
+
+/* Owner only. Like mpsc_pop, but only for the cells claimed before end,
+ * waiting for their producers to publish them. */
+static inline int mpsc_pop_before(mpsc_ring_t *r, unsigned long end, CBV_PTR_TYPE *cb, char *last) {
+   if (r->head.val == end)
+      return 0;
+   while (!mpsc_pop(r, cb, last))
+      ;
+   return 1;
+}
+
+/*
+ * Producers which must not push to a ring whose owner changed meanwhile bracket
+ * the check of the owner and the push with mpsc_enter/mpsc_leave. Once
+ * mpsc_quiesce returns, the producers which entered before it are gone.
+ * Entering is a full barrier, so that the check of the owner cannot happen before.
+ */
+static inline int mpsc_enter(mpsc_ring_t *r) {
+   int phase = r->phase;
+   __sync_fetch_and_add(&r->in_flight[phase].val, 1);
+   return phase;
+}
+
+static inline void mpsc_leave(mpsc_ring_t *r, int phase) {
+   __sync_fetch_and_sub(&r->in_flight[phase].val, 1);
+}
+
+/* Owner only. New producers enter the other phase while we wait for the ones
+ * of the current phase, so that they cannot delay us forever. Done twice: a
+ * producer may have read the phase before the previous call and entered after. */
+static inline void mpsc_quiesce(mpsc_ring_t *r) {
+   for (int i = 0; i < 2; i++) {
+      int phase = r->phase;
+      r->phase = !phase;
+      __sync_synchronize();
+      while (__atomic_load_n(&r->in_flight[phase].val, __ATOMIC_ACQUIRE))
+         ;
+   }
+}
+
+/* Owner only. Detach the whole overflow list (to be drained after the ring).
+ * Nothing is returned while a producer still has a claimed but unpublished cell:
+ * its callback is older than the overflowed ones. */
+static inline struct mpsc_overflow * mpsc_take_overflow(mpsc_ring_t *r) {
+   if (!r->overflow_pending || mpsc_claimed(r) != r->head.val)
+      return NULL;
+
+   sl_mutex_lock(&r->overflow_mu);
+   struct mpsc_overflow *o = r->overflow_first;
+   r->overflow_first = NULL;
+   r->overflow_last = NULL;
+   r->overflow_pending = 0;
+   sl_mutex_unlock(&r->overflow_mu);
+   return o;
+}
+
+#endif /* MPSC_RING_H_ */
@@ -22,17 +22,71 @@
 #ifndef RUNTIME_CONFIG_H
 #define RUNTIME_CONFIG_H
 
+/**
+ * NB_TASKS_FROM_SAME_COLOR_THRES, SCHED_AGE_ALL, BATCH_TASKS, REMOVE_EPOLL_TIMEOUT, SPIN_BEFORE_SLEEP, POLL_INTERVAL,
+ * POLL_BUDGET, TIMER_SLACK, EPOLL_ONESHOT, IO_URING, STEALING, MAX_FREETASKS and CB_POOLS
+ * are defaults that can be overridden at startup (see runtime_params.h).
+ */
+
 /** How many tasks from the same color do we have to execute ? **/
 #define NB_TASKS_FROM_SAME_COLOR_THRES                  1
 
 #define REMOVE_EPOLL_TIMEOUT                            0
 
+/** Max time (us) an idle thread polls epoll without blocking before sleeping in epoll_wait. 0 = block at once **/
+#define SPIN_BEFORE_SLEEP                               0
+
+/** The scheduler loop polls the fds (and timers) every POLL_INTERVAL tasks, and when it has nothing to run **/
+#define POLL_INTERVAL                                   64
+/** Max number of fd events handled per poll, the others wait for the next poll **/
+#define POLL_BUDGET                                     256
+#define POLL_BATCH_MIN                                  16    /* Each thread adapts its batch between this and POLL_BUDGET */
+/** Register the fds with EPOLLONESHOT: one epoll_ctl per event (re-arm) instead of two (see _epoll_update) **/
+#define EPOLL_ONESHOT                                   0
+/** Watch the fds with one io_uring per thread instead of epoll, and allow aread/awrite/aaccept/arecv (see core_uring.C) **/
+#define IO_URING                                        0
+#define URING_ENTRIES                                   256   /* SQ size of each ring */
+#define URING_BUF_COUNT                                 256   /* Provided buffers of arecv per thread (power of 2) */
+#define URING_BUF_SIZE                                  4096
+
 #define STEALING                                        0
 #define RESET_COLOR_ON_EMPTY_QUEUE                      0
 
+/** Tasks of the active color run per TASK_MU acquisition (BATCH_TASKS runtime parameter, at most MAX_BATCH_TASKS) **/
+#define BATCH_TASKS                                     1
+#define MAX_BATCH_TASKS                                 64
+#define BATCH_TASKS_TARGET_CYCLES                       20000ULL  /* The batch size is adapted to run for about this long */
+
+/**
+ * Age all the waiting colors when a color is rotated, not only the ones it passes: rotation no
+ * longer walks the queue (one FIFO per priority, see insert_in_tl)
+ **/
+#define SCHED_AGE_ALL                                   0
+/** Distinct priorities a thread queue keeps apart (SCHED_AGE_ALL). More priorities share the nearest level **/
+#define SCHED_LEVELS                                    16
+
+/** Per-thread timing wheels for delaycb/timecb (see timer_wheel.h): 4 levels of 64 slots of 1 ms reach 4.6 hours **/
+#define TIMER_WHEEL_TICK_NS                             1000000ULL
+#define TIMER_WHEEL_LEVELS                              4
+/** Time spent calibrating the TSC against CLOCK_MONOTONIC at startup (see clock.C) **/
+#define TSC_CALIBRATION_NS                              5000000ULL
+
+/** Default time (us) a timer may fire late, so that close deadlines share a tick and one wakeup (see timecb) **/
+#define TIMER_SLACK                                     0
+
 #define SET_MAXIMUM_PRIORITY                            1
 #define PADDING_SIZE                                    CACHE_LINE_SIZE
 #define MAX_FREETASKS                                   300
+#define MAX_FREE_TASK_LISTS                             1024  /* Task lists of drained colors kept per thread for reuse */
+
+/** Allocate callbacks from per-thread slab pools instead of malloc (can be changed at startup) **/
+#define CB_POOLS                                        0
+
+/** INTRUSIVE_TASKS (callbacks embed their task node) changes their layout: see callback_norefcount.h **/
+
+/** Post to other threads through a per-thread MPSC ring instead of taking TASK_MU **/
+#define USE_MPSC_QUEUES                                 0
+#define MPSC_RING_SIZE                                  4096  /* Power of 2 */
 
 //#define HARDWARE_COUNTERS                               1
 
@@ -0,0 +1,68 @@
+/*
+ *
+ * Copyright (C) 2010 Sardes Project INRIA France
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ *
+ */
+
+/**
+ * Scheduler parameters that can be changed without rebuilding.
+ *
+ * Defaults are the values of runtime_config.h and ws_config.lbc.h. They are
+ * overridden at async_init::start() time, first by the file named by the
+ * MELY_CONFIG environment variable (one "NAME = value" per line, '#' comments),
+ * then by MELY_<NAME> environment variables (e.g. MELY_STEALING=1).
+ *
+ * Parameters changing the shape of the scheduler (stealing, time left stealing)
+ * select a specialized version of the scheduler once at startup (see task.lbc.C).
+ */
+
+#ifndef RUNTIME_PARAMS_H
+#define RUNTIME_PARAMS_H
+
+#include "runtime_config.h"
+#include "ws_config.lbc.h"
+
+typedef struct {
+   int stealing;                          /* STEALING */
+   int ce_ws;                             /* CE_WS */
+   int use_batch_ws;                      /* USE_BATCH_WS */
+   double batch_task_ws;                  /* BATCH_TASK_WS */
+   int adaptive_ws;                       /* ADAPTIVE_WS */
+   int time_left_workstealing;            /* TIME_LEFT_WORKSTEALING */
+   int nb_tasks_from_same_color_thres;    /* NB_TASKS_FROM_SAME_COLOR_THRES */
+   int sched_age_all;                     /* SCHED_AGE_ALL: a rotated color ages all the waiting ones */
+   int batch_tasks;                       /* BATCH_TASKS: max tasks of a color run per lock acquisition */
+   int max_freetasks;                     /* MAX_FREETASKS */
+   int remove_epoll_timeout;              /* REMOVE_EPOLL_TIMEOUT */
+   int spin_before_sleep;                 /* SPIN_BEFORE_SLEEP: us of non blocking epoll polls before blocking */
+   int poll_interval;                     /* POLL_INTERVAL: tasks run between two polls of the fds */
+   int poll_budget;                       /* POLL_BUDGET: max fd events handled per poll */
+   int epoll_oneshot;                     /* EPOLL_ONESHOT: keep the fds registered, disarmed by the kernel on events */
+   int io_uring;                          /* IO_URING: io_uring instead of epoll (core_uring.C) */
+   int timer_slack;                       /* TIMER_SLACK: us a timer may be late, unless given to timecb/delaycb */
+   int max_colors;                        /* MAX_COLORS: size of the color space */
+   int cb_pools;                          /* CB_POOLS: allocate callbacks from per-thread pools (cb_pool.C) */
+} runtime_params_t;
+
+extern runtime_params_t runtime_params;
+#define RT_PARAM(name)                  (runtime_params.name)
+
+/** Read the config file and the environment. Must be called before any other initialization. **/
+void load_runtime_params();
+
+#endif //RUNTIME_PARAMS_H
@@ -24,6 +24,7 @@
 #include "mely.h"
 #include "pad.h"
 #include "runtime_config.h"
+#include "ws_config.lbc.h"
 
 #include <map>
 
@@ -42,6 +43,7 @@ struct _thread_stats{
 #ifdef TRACE_CONTENTION
    uint64_t time_in_contention;
    uint64_t lock_nb_calls;
+   uint64_t mpsc_overflow_count;
 #endif
 
 #ifdef TRACE_CHOOSE_TASK
@@ -66,7 +68,7 @@ struct _thread_stats{
    unsigned long long workstealing_count;
    unsigned long long workstealing_try_steal;
 
-   uint64_t workstealing_per_thread_count[MAX_THREADS];
+   uint64_t workstealing_per_level_count[WS_NB_LEVELS];
 
    unsigned long long nb_tasks_stolen_per_steal;
    unsigned long long nb_colors_stolen_per_steal;
@@ -90,6 +92,12 @@ struct _thread_stats{
 #ifdef PROFILING_SUPPORT
    //used to take into account the register_task in runtime cost (and not in cb_exec_time)
    unsigned long long register_task_time;
+
+   /** Polls of the fds by the scheduler loop (see _rt_poll) **/
+   uint64_t polls;
+   uint64_t blocking_polls;
+   uint64_t polls_at_budget;                 /* Polls which returned POLL_BUDGET events */
+   uint64_t poll_events;
 #endif
 
 #if TRACE_REGISTER_TASK
@@ -150,15 +158,44 @@ struct _thread_stats{
    uint64_t core_epoll_callback_cost;
    uint64_t core_epoll_wait_cost;
    uint64_t core_epoll_avg_ret;
+   uint64_t core_epoll_batch_sum;         /* Sum of the events asked per poll (see fdcb_fdwatcher_check) */
+   uint64_t core_epoll_batch_full;        /* Polls which returned a full batch */
 
    uint64_t core_epoll_reg_cost;
    uint64_t core_epoll_already_reg_cost;
-   uint64_t core_epoll_reg_epoll_remove_cost;
+   uint64_t core_epoll_fd_migrations;      /* fds moved to the epoll of the thread running their color */
    uint64_t core_epoll_internal_add_cost;
    uint64_t core_epoll_internal_remove_cost;
    uint64_t core_epoll_cleanpipe_cost;
    uint64_t core_epoll_time_between_two_calls;
    uint64_t core_epoll_last_call_time;
+   uint64_t core_epoll_ctl_calls;
+   uint64_t core_epoll_ctl_skipped;       /* epoll_ctl calls avoided, the registration did not change */
+   uint64_t core_epoll_timer_wakeups;     /* Blocking epoll_wait ended by its timeout */
+   uint64_t core_timers_fired;
+   uint64_t core_timer_batches;           /* timecb_check calls that expired timers */
+#define LOG_EPOLL_BATCH(batch, n) \
+   do { \
+      CORE_STATS.core_epoll_batch_sum += (batch); \
+      if((n) == (batch)) \
+         CORE_STATS.core_epoll_batch_full++; \
+   } while(0);
+#define LOG_EPOLL_CTL_SKIPPED() \
+   do { \
+      CORE_STATS.core_epoll_ctl_skipped++; \
+   } while(0);
+#define LOG_EPOLL_TIMER_WAKEUP(timeout, n) \
+   do { \
+      if((timeout) > 0 && (n) == 0) \
+         CORE_STATS.core_epoll_timer_wakeups++; \
+   } while(0);
+#define LOG_TIMERS_FIRED(nb) \
+   do { \
+      if(nb) { \
+         CORE_STATS.core_timer_batches++; \
+         CORE_STATS.core_timers_fired += (nb); \
+      } \
+   } while(0);
 #define LOG_EPOLL_REMOVE(...) \
    do { \
       uint64_t epoll_internal_remove_start, epoll_internal_remove_stop; \
@@ -166,6 +203,7 @@ struct _thread_stats{
       __VA_ARGS__ \
       rdtscll(epoll_internal_remove_stop); \
       CORE_STATS.core_epoll_internal_remove_cost += (epoll_internal_remove_stop - epoll_internal_remove_start); \
+      CORE_STATS.core_epoll_ctl_calls++; \
    } while(0);
 #define LOG_EPOLL_ADD(...) \
    do { \
@@ -174,14 +212,11 @@ struct _thread_stats{
       __VA_ARGS__ \
       rdtscll(epoll_internal_add_stop); \
       CORE_STATS.core_epoll_internal_add_cost += (epoll_internal_add_stop - epoll_internal_add_start); \
+      CORE_STATS.core_epoll_ctl_calls++; \
    } while(0);
-#define LOG_REMOVE_COST(...) \
+#define LOG_FD_MIGRATION() \
    do { \
-	   uint64_t epoll_reg_remove_start, epoll_reg_remove_stop; \
-	   rdtscll(epoll_reg_remove_start); \
-	   __VA_ARGS__ \
-	   rdtscll(epoll_reg_remove_stop); \
-	   CORE_STATS.core_epoll_reg_epoll_remove_cost += (epoll_reg_remove_stop - epoll_reg_remove_start); \
+      CORE_STATS.core_epoll_fd_migrations++; \
    } while(0);
 #define LOG_START_FD_POLL_CHECK(...) \
    do { \
@@ -225,11 +260,15 @@ struct _thread_stats{
 #else
 #define LOG_EPOLL_REMOVE(...) __VA_ARGS__
 #define LOG_EPOLL_ADD(...) __VA_ARGS__
-#define LOG_REMOVE_COST(...) __VA_ARGS__
 #define LOG_START_FD_POLL_CHECK(...) __VA_ARGS__
 #define LOG_EPOLL_WAIT_TIME(...) __VA_ARGS__
 #define LOG_PIPE_CLEANING(...) __VA_ARGS__
 #define LOG_FDWATCHER_CHECK(...) __VA_ARGS__
+#define LOG_EPOLL_CTL_SKIPPED()
+#define LOG_EPOLL_BATCH(batch, n)
+#define LOG_FD_MIGRATION()
+#define LOG_EPOLL_TIMER_WAKEUP(timeout, n)
+#define LOG_TIMERS_FIRED(nb)
 #endif
 
    /** Warning: when adding new map, you must update _reset_stats **/
@@ -257,9 +296,15 @@ struct _thread_stats{
 
 
 typedef PAD_TYPE(struct _thread_stats, PADDING_SIZE) thread_stats_t;
-extern thread_stats_t thread_stats[MAX_THREADS+1];
+extern thread_stats_t *thread_stats;
 extern __thread unsigned int _thread_no;
 #define THREAD_STATS                    (thread_stats[_thread_no].val)
 #define STATS(i)                        (thread_stats[i].val)
 
+#ifdef TRACE_WORKSTEALING
+/** Steals done by a thief on a victim (nthreads x nthreads, outside thread_stats because its size is dynamic) **/
+extern uint64_t *workstealing_per_thread_count;
+#define WS_PER_THREAD_COUNT(thief, victim)   (workstealing_per_thread_count[(thief) * nthreads + (victim)])
+#endif
+
 #endif /* RUNTIME_STATS_H_ */
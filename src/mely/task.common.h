@@ -45,16 +45,16 @@ using namespace std;
 #include "core.h"
 
 extern int nthreads;
-extern unsigned short cpu_map[MAX_THREADS];
+extern unsigned short *cpu_map;
 extern struct rusage usage;
 
-#if CE_WS
 typedef struct sibling {
         int core;
+        int level;                      /* enum ws_level */
         struct sibling *next;
 } sibling;
 extern sibling** shared_cache_vector;
-#endif
+extern const char *ws_level_name[WS_NB_LEVELS];
 
 #ifdef PROFILING_SUPPORT
 static uint64_t start_cycle;
@@ -69,11 +69,16 @@ static uint64_t stop_cycle;
 #define FREETASK(threadid)              (thread_state[threadid].val.free_task)
 #define FREETASK_COUNT(threadid)        (thread_state[threadid].val.freetask_count)
 #define TASK_COUNT(threadid)            (THREAD_STATE(threadid).task_count)
-#define COLOR_TO_QUEUE(color)           color_to_queue[color].val
 #define ACOLOR(thread_no)               acolor[thread_no].val
-#define SLEEPING(i)                     (THREAD_STATE(i).sleeping)
 
-static sl_mutex_t task_mu[MAX_THREADS];
+/** Threads blocked in epoll with nothing to run, one bit per thread (see try_to_wakeup) **/
+extern volatile unsigned long *idle_mask;
+#define IDLE_MASK_BITS                  (8 * sizeof(unsigned long))
+#define IDLE_WORD(i)                    (idle_mask[(i) / IDLE_MASK_BITS])
+#define IDLE_BIT(i)                     (1UL << ((i) % IDLE_MASK_BITS))
+#define SLEEPING(i)                     (IDLE_WORD(i) & IDLE_BIT(i))
+
+extern sl_mutex_t *task_mu;
 #define TASK_MU(threadid)               (task_mu[threadid])
 
 #if TRACE_CONTENTION
@@ -151,9 +156,9 @@ unsigned long get_bench_time();
 void task_print_queue(int which_thread);
 void dumpEventStates(int s);
 void print_EH_name(void *EH);
+void cb_pool_flush();
 
-#if CE_WS
 int init_shared_cache_vector();
-#endif
+int ws_level(int thief, int victim);
 #endif	/* _TASK_COMMON_H */
 
@@ -25,38 +25,28 @@
 #include "mely.h"
 #include "core.h"
 #include "ws_config.lbc.h"
+#include "runtime_params.h"
 #include "pad.h"
+#include "mpsc_ring.h"
 #include "runtime_stats.h"
 #include <map>
 #include <vector>
 
 /**
- * Tasks are represented by a linked lists
+ * Tasks are represented by a linked lists (struct mely_task, see callback_norefcount.h)
  * Each task is associated with a callback, a color and a priority
  * A special task could be dummy. Probably because we don't want to have empty lists
  */
-struct Task {
-   CBV_PTR_TYPE cb;
-   Task *next;
-   Task *prev;
-   bool dummy;
-   int color;
-   int prio;
+typedef struct mely_task Task;
 
-   Task (CBV_PTR_TYPE c) : cb (c), next (0), prev (0), dummy (false),
-   color (c->getcolor ()), prio (c->getprio ()) {
-   }
+inline mely_task::mely_task (callback<void> *c) : cb (c), next (0), prev (0), dummy (false),
+  color (c->getcolor ()), prio (c->getprio ()), duration (c->get_timeleft ()) {
+}
 
-   Task (int task_color) : cb (NULL), next (NULL), prev (NULL), dummy (true),
-            color (task_color), prio (0) {
-   }
+inline void mely_task::setcb (callback<void> *c) {
+  cb = c; dummy = false; color = c->getcolor (); prio = c->getprio (); duration = c->get_timeleft ();
+}
 
-   void clear () {
-      cb = NULL;
-   }
-   void setcb (CBV_PTR_TYPE c)
-   { cb = c; color = c->getcolor (); prio = c->getprio (); }
-};
 
 struct Task_List {
    Task *first_task;
@@ -74,25 +64,48 @@ struct Task_List {
    int nb_callbacks;
 
    int color;
-   int current_prio;
+   int current_prio;                      /* Priority when inserted, aged by the sched_clock of the thread since then */
    int default_prio;
+   int sched_level;                       /* Index in sched_levels while in the thread's queue */
+   uint64_t sched_clock;
+   uint64_t sched_seq;
 
    int dummy;
-#if TIME_LEFT_WORKSTEALING
-   uint64_t total_processing_duration;
+   uint64_t total_processing_duration;    /* Only maintained with time left workstealing */
+};
+
+#if SCHED_LEVELS > 31
+#error "SCHED_LEVELS must fit in the sched_levels_used bitmap"
 #endif
+
+/** Colors of a thread's queue inserted with the same priority, in FIFO order **/
+struct sched_level {
+   int prio;
+   bool shared;                           /* Also holds other priorities: ordered by sched_before */
+   Task_List *first;
+   Task_List *last;
 };
 
 /** This structure represents a thread **/
 struct _thread_private {
    volatile int task_count;
 
-   struct Task *free_task;
+   Task *free_task;
    int freetask_count;
 
-   /** List of color in the thread's queue **/
+   /** Task lists of drained colors, reused for the next colors posted to this thread **/
+   Task_List *free_tl;
+   int free_tl_count;
+
+   /**
+    * Colors in the thread's queue (see insert_in_tl): one FIFO per priority level.
+    * color_list is the next color to run.
+    **/
    Task_List * color_list;
-   Task_List * last_of_color_list;
+   struct sched_level sched_levels[SCHED_LEVELS];
+   unsigned int sched_levels_used;        /* Bitmap of the non empty levels */
+   uint64_t sched_clock;                  /* SCHED_AGE_ALL: tasks executed by the rotated colors, ages the waiting ones */
+   uint64_t sched_seq;
 
    int steal_color_list_count;
    Task_List * steal_color_list;
@@ -107,14 +120,30 @@ struct _thread_private {
    /** How many tasks from the same color have we already executed ? **/
    int nb_tasks_from_color_executed;
 
+   /** Average duration of the handlers run by batches (cycles), see _rt_batch_size **/
+   uint64_t batch_avg_cycles;
+
+   /** Tasks left to run before the next poll of the fds and timers, see _rt_poll **/
+   int tasks_before_poll;
+
    /** Have we been stolen ? **/
    int has_been_stolen;
    int was_stealable;
 
+   /** Adaptive stealing (ADAPTIVE_WS) **/
+   double ws_batch;                       /* Part of the victim's stealable colors taken by a steal */
+   int times_stolen;                      /* Successful steals on this thread, under TASK_MU */
+   int times_stolen_seen;                 /* times_stolen at our last successful steal */
+   int ws_stole;                          /* Our last steal succeeded, ws_batch not adapted yet */
+
    /** Number of colors in the thread's task lists **/
    int num_unique_colors;
 
-   char sleeping;
+#if USE_MPSC_QUEUES
+   /** With stealing, callbacks a thief found in our ring for a color we do not own, forwarded at our next drain (under TASK_MU) **/
+   struct mpsc_overflow * stray_first;
+   struct mpsc_overflow * stray_last;
+#endif
 };
 
 typedef PAD_TYPE(struct _thread_private, PADDING_SIZE) thread_private_t;
@@ -128,6 +157,8 @@ void task_go ();
 /** Runtime function **/
 int register_task (CBV_PTR_TYPE cb);
 int register_task_head (CBV_PTR_TYPE cb);
+void register_tasks (CBV_PTR_TYPE *cbs, int n);            /* Same as register_task on each callback, one lock and wakeup per thread */
+int task_queue_length (int thread);
 
 /** Manipulating colors **/
 void inc_color_count(int which_thread, int color);
@@ -0,0 +1,195 @@
+/*
+ *
+ * Copyright (C) 2010 Sardes Project INRIA France
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ *
+ */
+
+/**
+ * Hierarchical timing wheel (one per thread, see timecb in core.C).
+ *
+ * Time is counted in ticks of TIMER_WHEEL_TICK_NS. Level l has TIMER_WHEEL_SLOTS slots of
+ * TIMER_WHEEL_SLOTS^l ticks each. A timer goes to the lowest level where it is less than a
+ * revolution (in slots of that level) away, in the slot of its expiry. When the wheel reaches
+ * the first tick of a slot of level l > 0, the slot is cascaded: its timers are inserted again,
+ * at lower levels. Timers further than the top level can go wait in its last slot and are
+ * cascaded again until they are close enough.
+ *
+ * Insert and remove are O(1) (doubly linked slots), expiring is O(1) per timer plus the
+ * cascades. A bitmap of non empty slots per level gives the next tick at which something
+ * happens, to skip empty ticks and to compute the epoll timeout.
+ *
+ * The wheel is not synchronized: the caller protects it.
+ **/
+
+#ifndef TIMER_WHEEL_H_
+#define TIMER_WHEEL_H_
+
+#include <stdint.h>
+#include "runtime_config.h"
+
+#define TIMER_WHEEL_BITS          6
+#define TIMER_WHEEL_SLOTS         (1 << TIMER_WHEEL_BITS)     /* 64: one bit per slot in a uint64_t */
+#define TIMER_WHEEL_MASK          (TIMER_WHEEL_SLOTS - 1)
+
+#if TIMER_WHEEL_LEVELS * TIMER_WHEEL_BITS > 60
+#error "TIMER_WHEEL_LEVELS is too large"
+#endif
+
+struct timer_node {
+   struct timer_node *next;
+   struct timer_node *prev;
+   uint64_t expire;                       /* Tick */
+};
+
+struct timer_wheel {
+   uint64_t now;                          /* Last tick processed */
+   unsigned int count;                    /* Timers in the wheel */
+   uint64_t used[TIMER_WHEEL_LEVELS];     /* Non empty slots */
+   struct timer_node slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];   /* List heads */
+};
+
+static inline void tw_init(struct timer_wheel *w, uint64_t now) {
+   w->now = now;
+   w->count = 0;
+   for (int l = 0; l < TIMER_WHEEL_LEVELS; l++) {
+      w->used[l] = 0;
+      for (int s = 0; s < TIMER_WHEEL_SLOTS; s++)
+         w->slots[l][s].next = w->slots[l][s].prev = &w->slots[l][s];
+   }
+}
+
+static inline void _tw_place(struct timer_wheel *w, struct timer_node *n) {
+   uint64_t expire = n->expire > w->now ? n->expire : w->now + 1;
+   int l;
+   for (l = 0; l < TIMER_WHEEL_LEVELS - 1; l++)
+      if ((expire >> (l * TIMER_WHEEL_BITS)) - (w->now >> (l * TIMER_WHEEL_BITS)) < TIMER_WHEEL_SLOTS)
+         break;
+
+   uint64_t pos = expire >> (l * TIMER_WHEEL_BITS);
+   uint64_t cur = w->now >> (l * TIMER_WHEEL_BITS);
+   if (pos - cur >= TIMER_WHEEL_SLOTS)
+      pos = cur + TIMER_WHEEL_SLOTS - 1;  /* Too far: wait in the last slot of the top level */
+
+   int s = pos & TIMER_WHEEL_MASK;
+   struct timer_node *head = &w->slots[l][s];
+   n->next = head->next;
+   n->prev = head;
+   head->next->prev = n;
+   head->next = n;
+   w->used[l] |= 1ULL << s;
+}
+
+static inline void tw_insert(struct timer_wheel *w, struct timer_node *n) {
+   _tw_place(w, n);
+   w->count++;
+}
+
+/* Unlink a node, and clear the bit of its slot if it became empty (the slot is found from its head) */
+static inline void tw_remove(struct timer_wheel *w, struct timer_node *n) {
+   struct timer_node *next = n->next, *prev = n->prev;
+   prev->next = next;
+   next->prev = prev;
+   n->next = n->prev = NULL;
+   w->count--;
+
+   if (next == prev) {
+      uintptr_t off = (uintptr_t) next - (uintptr_t) w->slots;
+      if (off < sizeof(w->slots)) {
+         unsigned long i = off / sizeof(struct timer_node);
+         w->used[i / TIMER_WHEEL_SLOTS] &= ~(1ULL << (i % TIMER_WHEEL_SLOTS));
+      }
+   }
+}
+
+/* First tick after now at which something has to be done (expiry or cascade), UINT64_MAX if none */
+static inline uint64_t tw_next_tick(struct timer_wheel *w) {
+   uint64_t best = UINT64_MAX;
+   if (!w->count)
+      return best;
+
+   for (int l = 0; l < TIMER_WHEEL_LEVELS; l++) {
+      if (!w->used[l])
+         continue;
+      uint64_t cur = w->now >> (l * TIMER_WHEEL_BITS);
+      int shift = (cur + 1) & TIMER_WHEEL_MASK;
+      uint64_t bits = (w->used[l] >> shift) | (shift ? w->used[l] << (TIMER_WHEEL_SLOTS - shift) : 0);
+      uint64_t tick = (cur + 1 + __builtin_ctzll(bits)) << (l * TIMER_WHEEL_BITS);
+      if (tick < best)
+         best = tick;
+   }
+   return best;
+}
+
+/* Take all the timers of a slot, as a list linked by next */
+static inline struct timer_node *_tw_take_slot(struct timer_wheel *w, int l, int s) {
+   struct timer_node *head = &w->slots[l][s];
+   if (head->next == head)
+      return NULL;
+   head->prev->next = NULL;
+   struct timer_node *list = head->next;
+   head->next = head->prev = head;
+   w->used[l] &= ~(1ULL << s);
+   return list;
+}
+
+/**
+ * Move the wheel to tick now. Returns the expired timers as a list linked by next
+ * (they are not in the wheel anymore).
+ **/
+static inline struct timer_node *tw_advance(struct timer_wheel *w, uint64_t now) {
+   struct timer_node *expired = NULL;
+
+   while (w->now < now) {
+      uint64_t t = tw_next_tick(w);
+      if (t > now) {
+         w->now = now;
+         break;
+      }
+      w->now = t;
+
+      /** Cascade the slots starting at t, highest level first **/
+      for (int l = TIMER_WHEEL_LEVELS - 1; l > 0; l--) {
+         if (t & ((1ULL << (l * TIMER_WHEEL_BITS)) - 1))
+            continue;
+         struct timer_node *n = _tw_take_slot(w, l, (t >> (l * TIMER_WHEEL_BITS)) & TIMER_WHEEL_MASK);
+         while (n) {
+            struct timer_node *next = n->next;
+            if (n->expire <= t) {
+               n->next = expired;
+               expired = n;
+               w->count--;
+            } else {
+               _tw_place(w, n);
+            }
+            n = next;
+         }
+      }
+
+      struct timer_node *n = _tw_take_slot(w, 0, t & TIMER_WHEEL_MASK);
+      while (n) {
+         struct timer_node *next = n->next;
+         n->next = expired;
+         expired = n;
+         w->count--;
+         n = next;
+      }
+   }
+   return expired;
+}
+
+#endif /* TIMER_WHEEL_H_ */
@@ -23,9 +23,10 @@
 
 #include "runtime_config.h"
 
-#if STEALING
-
-#define WS_FUNCTION                             steal_work
+/**
+ * Stealing defaults. TIME_LEFT_WORKSTEALING, CE_WS, USE_BATCH_WS, BATCH_TASK_WS and ADAPTIVE_WS
+ * can be overridden at startup (see runtime_params.h).
+ */
 
 /**
  * Optim 1: time left workstealing: steal long tasks first.
@@ -34,6 +35,10 @@
 #define TIME_LEFT_WORKSTEALING                  0
 #define MUST_STEAL_THRESHOLD                    1000
 
+/** Callbacks posted without a time left get the average duration measured for their handler **/
+#define HANDLER_DURATIONS_SIZE                  4096  /* Handlers tracked, power of 2 */
+#define HANDLER_DURATIONS_PROBES                8
+
 #define SORT_STEAL_LIST                         0     /* TIME_LEFT_WORKSTEALING MUST BE 1 */
 #define MEDIUM_THRES                            15000 /* A colors which represents more than 15000 is appealing...*/
 #define HIGH_THRES                              30000 /* and more than 30000 is super appealing ! */
@@ -43,13 +48,36 @@
  */
 #define CE_WS                                   0
 
+/**
+ * Distance between a thief and its victim, closest first.
+ * CE_WS tries victims in this order (built from sysfs, see init_shared_cache_vector).
+ */
+enum ws_level {
+   WS_LEVEL_SMT = 0,                            /* Same physical core */
+   WS_LEVEL_L2,                                 /* Share a L2 cache */
+   WS_LEVEL_L3,                                 /* Share the last level cache */
+   WS_LEVEL_NODE,                               /* Same NUMA node */
+   WS_LEVEL_REMOTE,                             /* Other NUMA node */
+   WS_NB_LEVELS
+};
+
 /**
  * Optim 3: batch steal (~50% of available tasks)
  */
 #define USE_BATCH_WS                            1
 #define BATCH_TASK_WS                           0.5
 
-#endif
+/**
+ * Optim 4: adaptive stealing. Victims are chosen by their number of stealable colors (read
+ * without lock), closest first with CE_WS, ties broken at random. The part of the victim's colors
+ * stolen starts at BATCH_TASK_WS and is adapted by each thief: decreased when the thief was itself
+ * stolen since its last steal (it took too much), increased otherwise (it ran out of work).
+ */
+#define ADAPTIVE_WS                             0
+#define ADAPTIVE_WS_MIN_BATCH                   0.125
+#define ADAPTIVE_WS_MAX_BATCH                   0.75
+#define ADAPTIVE_WS_INCREASE                    0.0625 /* Additive increase... */
+#define ADAPTIVE_WS_DECREASE                    0.75   /* ... multiplicative decrease */
 
 #if SORT_STEAL_LIST && !TIME_LEFT_WORKSTEALING
 #error "You must use TIME_LEFT_WORKSTEALING to activate SORT_STEAL_LIST"